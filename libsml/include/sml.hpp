@@ -6,9 +6,22 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <istream>
+#include <ostream>
 #include <stack>
 #include <algorithm>
+#include <stdexcept>
+
+// parsing at compile time needs constexpr strings and vectors and class type template parameters
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L && \
+    defined(__cpp_lib_constexpr_string) && __cpp_lib_constexpr_string >= 201907L &&  \
+    defined(__cpp_lib_constexpr_vector)
+#define SML_STATIC_PARSE
+#include <array>
+#include <iterator>
+#include <string_view>
+#endif
 
 namespace sml
 {
@@ -35,6 +48,87 @@ namespace sml
         Location location;         // location from the source stream
     };
 
+    /**
+     * @brief Immutable sml tag whose subtrees are reference counted and shared between copies
+     * @remarks Copies are cheap and safe to read from many threads without locking. Edits return a
+     * new node which shares every subtree that was left untouched.
+     */
+    class SharedNode
+    {
+    private:
+        struct Data
+        {
+            std::string tagName;
+            std::string content;
+            std::vector<SharedNode> children;
+            std::map<std::string, std::string> attributes;
+
+            std::size_t contentOffset;
+            Location location;
+        };
+
+        std::shared_ptr<const Data> m_data;
+
+        explicit SharedNode(std::shared_ptr<const Data> data);
+
+        template <typename EditType>
+        SharedNode edit(EditType editData) const;
+
+    public:
+        /**
+         * @brief Constructs an empty node with no name, content, children or attributes
+         */
+        SharedNode();
+
+        /**
+         * @brief Constructs a shared copy of a node tree
+         * 
+         * @param node The node tree to be copied
+         */
+        explicit SharedNode(const Node &node);
+
+        const std::string &tagName() const;
+        const std::string &content() const;
+        const std::vector<SharedNode> &children() const;
+        const std::map<std::string, std::string> &attributes() const;
+
+        std::size_t contentOffset() const;
+        Location location() const;
+
+        /**
+         * @brief Gets a descendant of this node
+         * 
+         * @param path The index of the child to follow at each level
+         * @return const SharedNode& The node at the end of the path
+         */
+        const SharedNode &at(const std::vector<std::size_t> &path) const;
+
+        SharedNode withTagName(std::string tagName) const;
+        SharedNode withContent(std::string content) const;
+        SharedNode withAttribute(const std::string &name, std::string value) const;
+        SharedNode withoutAttribute(const std::string &name) const;
+        SharedNode withChild(std::size_t index, SharedNode child) const;
+        SharedNode withChildInserted(std::size_t index, SharedNode child) const;
+        SharedNode withoutChild(std::size_t index) const;
+
+        /**
+         * @brief Replaces a descendant of this node
+         * @remarks Only the nodes along the path are copied, all other subtrees are shared
+         * 
+         * @param path The index of the child to follow at each level
+         * @param replacement The node to put at the end of the path
+         * @return SharedNode The new root
+         */
+        SharedNode withDescendant(const std::vector<std::size_t> &path, SharedNode replacement) const;
+
+        /**
+         * @brief Creates a deep, mutable copy of the node tree
+         * 
+         * @return Node The copied node tree
+         */
+        Node toNode() const;
+    };
+
     /**
      * @brief General error throw by the parser when it cannot continue.
      */
@@ -49,9 +143,99 @@ namespace sml
     };
 
     /**
-     * @brief Builder class which constructs a node tree from a stream of chars
+     * @brief Represents an opening tag as seen by an event handler
      */
-    class Parser
+    struct Element
+    {
+        std::string tagName;
+        std::map<std::string, std::string> attributes;
+
+        Location location; // location from the source stream
+    };
+
+    /**
+     * @brief Receives the events produced while parsing a sml stream
+     * @remarks Events arrive in document order, every startElement is matched by exactly one endElement
+     */
+    class EventHandler
+    {
+    public:
+        virtual ~EventHandler() = default;
+
+        /**
+         * @brief Called once the open tag of an element has been fully read
+         * 
+         * @param element The tag name, attributes and location of the element
+         */
+        virtual void startElement(const Element &element) = 0;
+
+        /**
+         * @brief Called by StreamParser in place of startElement, the handler may take the contents of the element
+         * @remarks Defaults to startElement
+         * 
+         * @param element The tag name, attributes and location of the element
+         */
+        virtual void consumeElement(Element &element);
+
+        /**
+         * @brief Called with raw character data found within the most recently started element
+         * @remarks Content is unstripped and may be delivered over several calls
+         * 
+         * @param content The characters read
+         */
+        virtual void content(const std::string &content) = 0;
+
+        /**
+         * @brief Called when the most recently started element is closed
+         */
+        virtual void endElement() = 0;
+    };
+
+    namespace detail
+    {
+        // shared by StreamParser and the compile time parser so that both accept the same documents
+
+        constexpr char OPEN_TAG = '<';
+        constexpr char TAG_END = '>';
+        constexpr char CLOSE_TAG_PREFIX = '/';
+        constexpr char ATTRIB_EQUALS_SIGN = '=';
+        constexpr char ATTRIB_VALUE_WRAP = '"';
+
+        constexpr bool isWhitespace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+        }
+
+        constexpr bool isValidNameChar(char c)
+        {
+            return !isWhitespace(c) && c != OPEN_TAG && c != TAG_END && c != ATTRIB_EQUALS_SIGN && c != CLOSE_TAG_PREFIX;
+        }
+
+        // parser error messages, those ending in ": " are followed by the quoted character or tag name
+
+        constexpr char TAG_AFTER_ROOT_ERROR[] = "opening new tag when the root tag has already been closed";
+        constexpr char CONTENT_AFTER_ROOT_ERROR[] = "declaring content when the root tag has already been closed";
+        constexpr char EXPECTED_ROOT_ERROR[] = "expected root tag, got unexpected character: ";
+        constexpr char EXPECTED_TAG_NAME_ERROR[] = "expected tag name got unexpected character: ";
+        constexpr char EXPECTED_ATTRIB_NAME_ERROR[] = "expected attrib name got unexpected character: ";
+        constexpr char EXPECTED_EQUALS_ERROR[] = "expected \"=\" got unexpected character: ";
+        constexpr char EXPECTED_VALUE_ERROR[] = "expected '\"' got unexpected character: ";
+        constexpr char UNEXPECTED_CLOSE_TAG_ERROR[] = "unexpected close tag: ";
+        constexpr char CLOSE_TAG_MISMATCH_ERROR[] = "expected close tag with tag name: "; // followed by the open tag name
+        constexpr char CLOSE_TAG_MISMATCH_GOT[] = " got: ";                                 // followed by the close tag name
+        constexpr char EXPECTED_TAG_END_ERROR[] = "expected '>' got unexpected character: ";
+        constexpr char EXPECTED_SINGLETON_END_ERROR[] = "expected '>' after '/' to close singleton tag, got unexpected character: ";
+        constexpr char UNEXPECTED_EOF_ERROR[] = "unexpected eof";
+        constexpr char NO_ROOT_ERROR[] = "no root node found!";
+        constexpr char UNCLOSED_TAG_ERROR[] = "unclosed tag: ";
+    }
+
+    /**
+     * @brief Parser which reports a stream of chars as events instead of building a node tree
+     * @remarks Memory use is bounded by the nesting depth of the document, long runs of content are
+     * passed on in several chunks
+     */
+    class StreamParser
     {
     private:
         enum class State
@@ -79,13 +263,25 @@ namespace sml
             State nextState;
         };
 
-        std::stack<Node> m_nodeStack;
+        friend class Parser;
+
+        EventHandler *m_handler;
+
+        struct OpenTag
+        {
+            std::string tagName;
+            Location location;
+        };
+
+        std::vector<OpenTag> m_openTags;
+
+        Element m_currentElement;
+        std::string m_currentCloseName;
+        std::string m_currentContent;
 
         std::string m_currentAttribName;
         std::string m_currentAttribValue;
 
-        bool m_equalsSeen = false;
-        bool m_terminalTag = false;
         bool m_rootClosed = false;
 
         StateChange start(char c);
@@ -98,11 +294,78 @@ namespace sml
         StateChange close_name(char c);
         StateChange singleton(char c);
 
+        void flushContent();
+        void openCurrentElement();
+        void closeElement();
+
         State m_currentState = State::START;
 
         Location m_currentLocation = Location{1, 1};
 
     public:
+        /**
+         * @brief Constructs a parser which reports to the given handler
+         * 
+         * @param handler The handler to receive events, must outlive the parser
+         */
+        explicit StreamParser(EventHandler &handler);
+
+        /**
+         * @brief Resets the parser to an initial state to parse another stream
+         */
+        void reset();
+
+        /**
+         * @brief Gives the parser another character and handles it based on its current state
+         * 
+         * @param c character to handle
+         */
+        void handleChar(char c);
+
+        /**
+         * @brief Checks that the stream formed a complete document and resets the parser
+         */
+        void finish();
+    };
+
+    /**
+     * @brief Error thrown when a stream of events cannot be handled as it arrives
+     */
+    class StreamError : public std::runtime_error
+    {
+    public:
+        StreamError(const std::string &msg) : std::runtime_error("Stream error: " + msg)
+        {
+        }
+    };
+
+    /**
+     * @brief Builder class which constructs a node tree from a stream of chars
+     */
+    class Parser
+    {
+    private:
+        class TreeBuilder : public EventHandler
+        {
+        public:
+            std::stack<Node> nodeStack;
+
+            void startElement(const Element &element) override;
+            void consumeElement(Element &element) override;
+            void content(const std::string &content) override;
+            void endElement() override;
+        };
+
+        TreeBuilder m_builder;
+        StreamParser m_parser;
+
+    public:
+        Parser();
+        Parser(const Parser &other);
+        Parser(Parser &&other);
+        Parser &operator=(const Parser &other);
+        Parser &operator=(Parser &&other);
+
         /**
          * @brief Resets the builder to an initial state to build another node tree
          */
@@ -123,6 +386,115 @@ namespace sml
         Node finish();
     };
 
+    /**
+     * @brief Event handler which forwards events to another handler, allowing them to be altered on the way
+     * @remarks Override the filter hooks to drop, rename or modify elements. Extra elements can be emitted
+     * by calling the next handler directly from within a hook. Content is forwarded in runs split at the
+     * children which are kept, so content either side of a dropped child is forwarded as one run. Each run
+     * is held in memory so that filterContent sees it whole.
+     */
+    class Filter : public EventHandler
+    {
+    private:
+        struct OpenElement
+        {
+            Element element;
+            std::string content;
+        };
+
+        EventHandler &m_next;
+
+        std::vector<OpenElement> m_openElements;
+        std::size_t m_skipDepth = 0;
+
+        void flushContent();
+        void openElement(Element &element);
+
+    protected:
+        /**
+         * @brief Called for each element before it is forwarded
+         * @remarks The parent's content read so far is only forwarded once the element is kept, so elements
+         * emitted from here come before it
+         * 
+         * @param element The element which can be modified in place
+         * @return true to forward the element, false to drop it along with its entire subtree
+         */
+        virtual bool filterElement(Element &element);
+
+        /**
+         * @brief Called with each stripped run of content of a forwarded element before it is forwarded
+         * @remarks A run is the content up to the next kept child or the end of the element. It is only
+         * forwarded if it is not empty afterwards
+         * 
+         * @param content The content which can be modified in place
+         */
+        virtual void filterContent(std::string &content);
+
+        /**
+         * @brief Called just before the end of a forwarded element is forwarded
+         * 
+         * @param element The element as it was forwarded
+         */
+        virtual void finishElement(const Element &element);
+
+        /**
+         * @brief Gets the handler which the filter forwards to
+         */
+        EventHandler &next();
+
+    public:
+        /**
+         * @brief Constructs a filter which forwards to the given handler
+         * 
+         * @param next The handler to forward to, must outlive the filter
+         */
+        explicit Filter(EventHandler &next);
+
+        void startElement(const Element &element) final;
+        void consumeElement(Element &element) final;
+        void content(const std::string &content) final;
+        void endElement() final;
+    };
+
+    /**
+     * @brief Event handler which writes events out to a stream using the same formatting as sml::write
+     * @remarks sml::write puts all of a tag's content before its children, which cannot be done once the
+     * children have been written. Content following a child therefore causes a StreamError. Content is
+     * written as it arrives, holding back only whitespace which may turn out to be trailing.
+     */
+    class Writer : public EventHandler
+    {
+    private:
+        enum class TagState
+        {
+            OPEN,     // open tag not yet terminated
+            CONTENT,  // content has been written
+            CHILDREN  // children have been written
+        };
+
+        struct OpenTag
+        {
+            std::string tagName;
+            std::string pendingWhitespace; // may yet be stripped as trailing whitespace
+            TagState state;
+        };
+
+        std::ostream &m_output;
+        std::vector<OpenTag> m_openTags;
+
+    public:
+        /**
+         * @brief Constructs a writer which outputs to the given stream
+         * 
+         * @param output The output stream to be used, must outlive the writer
+         */
+        explicit Writer(std::ostream &output);
+
+        void startElement(const Element &element) override;
+        void content(const std::string &content) override;
+        void endElement() override;
+    };
+
     std::istream &operator>>(std::istream &str, sml::Node &node);
     std::ostream &operator<<(std::ostream &str, const sml::Node &node);
 
@@ -143,6 +515,23 @@ namespace sml
         return p.finish();
     }
 
+    /**
+     * @brief Parses sml from a given iterator range, reporting it to an event handler
+     * 
+     * @tparam IteratorType The iterator type to be used
+     * @param begin The starting iterator
+     * @param end The ending iterator
+     * @param handler The handler to receive events
+     */
+    template <typename IteratorType>
+    static void parse(IteratorType begin, IteratorType end, EventHandler &handler)
+    {
+        StreamParser p{handler};
+        std::for_each(begin, end, [&p](const auto &c)
+                      { p.handleChar(c); });
+        p.finish();
+    }
+
     /**
      * @brief Parses sml from a given string 
      * 
@@ -159,6 +548,23 @@ namespace sml
      */
     Node parse(std::istream &str);
 
+    /**
+     * @brief Parses sml from a given string, reporting it to an event handler
+     * 
+     * @param str The string to be interpreted as sml
+     * @param handler The handler to receive events
+     */
+    void parse(const std::string &str, EventHandler &handler);
+
+    /**
+     * @brief Parses sml from a given input stream, reporting it to an event handler
+     * @remarks Characters are handled as they are read so the whole stream is never held in memory
+     * 
+     * @param str The input stream to be interpreted as sml
+     * @param handler The handler to receive events
+     */
+    void parse(std::istream &str, EventHandler &handler);
+
     /**
      * @brief Writes out a sml node to a given output stream
      * 
@@ -174,4 +580,1075 @@ namespace sml
      * @param output The string to be outputed
      */
     void write(const Node &node, std::string &output);
+
+    /**
+     * @brief Writes out a shared node to a given output stream
+     * 
+     * @param node The node to be serialised
+     * @param output The output stream to be used
+     */
+    void write(const SharedNode &node, std::ostream &output);
+
+    /**
+     * @brief Writes out a shared node to a given output string
+     * 
+     * @param node The node to be serialised
+     * @param output The string to be outputed
+     */
+    void write(const SharedNode &node, std::string &output);
+
+#ifdef SML_STATIC_PARSE
+
+    namespace detail
+    {
+        struct StaticNode
+        {
+            std::size_t tagName, tagNameLength;
+            std::size_t content, contentLength;
+            std::size_t firstChild, childCount;
+            std::size_t firstAttribute, attributeCount;
+
+            std::size_t contentOffset;
+            Location location;
+        };
+
+        struct StaticAttribute
+        {
+            std::size_t name, nameLength;
+            std::size_t value, valueLength;
+        };
+
+        struct StaticTable
+        {
+            const StaticNode *nodes;
+            const StaticAttribute *attributes;
+            const char *chars;
+        };
+
+        template <std::size_t MaxMessageLength>
+        struct StaticError
+        {
+            std::array<char, MaxMessageLength> message;
+            std::size_t messageLength;
+            Location location;
+        };
+
+        struct StaticSpan
+        {
+            std::size_t offset, length;
+        };
+
+        /**
+         * @brief Constexpr counterpart of StreamParser which builds a transient tree
+         * @remarks Shares its characters, predicates and error messages with StreamParser, the state machine
+         * itself must be kept in step with StreamParser and Parser so both accept the same documents. Growing
+         * containers is costly during constant evaluation, so names, values and content are recorded as spans
+         * of the source in tables sized for the worst case, and linked together by index.
+         * 
+         * @tparam Length The length of the source
+         */
+        template <std::size_t Length>
+        class StaticParser
+        {
+        public:
+            // each node takes at least four characters ("<a/>"), as does each attribute ('a=""'), and each
+            // run of content at least one character followed by a tag
+            static constexpr std::size_t MAX_NODES = Length / 4 + 1;
+            static constexpr std::size_t MAX_ATTRIBUTES = Length / 4 + 1;
+            static constexpr std::size_t MAX_RUNS = Length / 2 + 1;
+
+            // a message is one fixed text followed by at most a quoted character or two quoted names taken
+            // from the source, so no message is longer than this
+            static constexpr std::size_t MAX_MESSAGE_LENGTH = sizeof(EXPECTED_SINGLETON_END_ERROR) + sizeof(CLOSE_TAG_MISMATCH_GOT) + 4 + Length;
+
+            using Span = StaticSpan;
+
+            struct Run
+            {
+                Span span;                  // content between two tags
+                std::size_t next, previous; // neighbouring runs of the same node
+            };
+
+            struct ParsedNode
+            {
+                Span tagName;
+                std::size_t firstAttribute, attributeCount;
+
+                std::size_t firstChild, lastChild, childCount;
+                std::size_t nextSibling;
+
+                std::size_t firstRun, lastRun, runCount;
+                std::size_t contentSkip;   // whitespace stripped from the start of the runs
+                std::size_t contentLength; // length of the content, stripped once the node is closed
+
+                std::size_t contentOffset;
+                Location location;
+            };
+
+            std::string_view source;
+
+            // nodes[0] is the root, each table is only used up to its count
+            std::array<ParsedNode, MAX_NODES> nodes{};
+            std::array<std::pair<Span, Span>, MAX_ATTRIBUTES> attributes{};
+            std::array<Run, MAX_RUNS> runs{};
+            std::size_t nodeCount = 0, attributeCount = 0, runCount = 0;
+
+            StaticError<MAX_MESSAGE_LENGTH> error{}; // messageLength is zero unless parsing failed
+
+        private:
+            enum class State
+            {
+                START,
+                NAME,
+                WHITESPACE,
+                ATTRIB_NAME,
+                ATTRIB_EQUALS,
+                ATTRIB_EQUALS_SEEN,
+                ATTRIB_VALUE,
+                CLOSE_NAME,
+                SINGLETON
+            };
+
+            std::array<std::size_t, MAX_NODES> m_openNodes{};
+            std::size_t m_depth = 0;
+
+            Span m_currentName{};
+            std::size_t m_currentFirstAttribute = 0;
+            Location m_currentTagLocation = Location{1, 1};
+            Span m_currentCloseName{};
+
+            Span m_currentAttribName{};
+            Span m_currentAttribValue{};
+
+            std::size_t m_contentStart = 0;
+
+            bool m_rootClosed = false;
+
+            State m_currentState = State::START;
+
+            std::size_t m_position = 0;
+            Location m_currentLocation = Location{1, 1};
+
+            static constexpr std::string quoted(std::string_view str)
+            {
+                return "\"" + std::string(str) + "\"";
+            }
+
+            static constexpr std::string quoted(char c)
+            {
+                return quoted(std::string_view(&c, 1));
+            }
+
+            // records the error and consumes the character so that parsing stops
+            constexpr bool fail(const std::string &msg, const Location &loc)
+            {
+                error.messageLength = msg.size();
+                std::copy(msg.begin(), msg.end(), error.message.begin());
+                error.location = loc;
+
+                return true;
+            }
+
+            constexpr std::string_view view(const Span &span) const
+            {
+                return source.substr(span.offset, span.length);
+            }
+
+            // content before a tag belongs to the innermost open node
+            constexpr void flushContent()
+            {
+                if (m_depth == 0 || m_position == m_contentStart)
+                {
+                    return;
+                }
+
+                ParsedNode &node = nodes[m_openNodes[m_depth - 1]];
+                std::size_t run = runCount++;
+                runs[run] = Run{Span{m_contentStart, m_position - m_contentStart}, 0, node.lastRun};
+
+                if (node.runCount == 0)
+                {
+                    node.firstRun = run;
+                }
+                else
+                {
+                    runs[node.lastRun].next = run;
+                }
+
+                node.lastRun = run;
+                node.runCount++;
+                node.contentLength += runs[run].span.length;
+            }
+
+            constexpr void openCurrentElement()
+            {
+                std::size_t index = nodeCount++;
+                ParsedNode &node = nodes[index];
+                node.tagName = m_currentName;
+                node.firstAttribute = m_currentFirstAttribute;
+                node.attributeCount = attributeCount - m_currentFirstAttribute;
+                node.location = m_currentTagLocation;
+
+                // hook the tag into its parents content if it exists
+                if (m_depth > 0)
+                {
+                    ParsedNode &parent = nodes[m_openNodes[m_depth - 1]];
+                    node.contentOffset = parent.contentLength;
+
+                    if (parent.childCount == 0)
+                    {
+                        parent.firstChild = index;
+                    }
+                    else
+                    {
+                        nodes[parent.lastChild].nextSibling = index;
+                    }
+
+                    parent.lastChild = index;
+                    parent.childCount++;
+                }
+
+                m_openNodes[m_depth++] = index;
+            }
+
+            constexpr void closeElement()
+            {
+                // strip content the same way as the runtime parser, the whitespace may span several runs
+                ParsedNode &node = nodes[m_openNodes[m_depth - 1]];
+
+                std::size_t left = 0;
+                for (std::size_t i = 0, run = node.firstRun; i < node.runCount; i++, run = runs[run].next)
+                {
+                    const Span &span = runs[run].span;
+
+                    std::size_t count = 0;
+                    while (count < span.length && isWhitespace(source[span.offset + count]))
+                    {
+                        count++;
+                    }
+
+                    left += count;
+                    if (count < span.length)
+                    {
+                        break;
+                    }
+                }
+
+                std::size_t right = 0;
+                for (std::size_t i = 0, run = node.lastRun; left < node.contentLength && i < node.runCount; i++, run = runs[run].previous)
+                {
+                    const Span &span = runs[run].span;
+
+                    std::size_t count = 0;
+                    while (count < span.length && isWhitespace(source[span.offset + span.length - count - 1]))
+                    {
+                        count++;
+                    }
+
+                    right += count;
+                    if (count < span.length)
+                    {
+                        break;
+                    }
+                }
+
+                node.contentSkip = left;
+                node.contentLength -= left + right;
+
+                for (std::size_t i = 0, child = node.firstChild; i < node.childCount; i++, child = nodes[child].nextSibling)
+                {
+                    nodes[child].contentOffset -= left;
+
+                    if (nodes[child].contentOffset >= node.contentLength)
+                    {
+                        nodes[child].contentOffset = node.contentLength - 1;
+                    }
+                }
+
+                m_depth--;
+
+                if (m_depth == 0)
+                {
+                    m_rootClosed = true;
+                }
+            }
+
+            // each state returns true if the character was consumed
+
+            constexpr bool start(char c)
+            {
+                if (c == OPEN_TAG)
+                {
+                    if (m_rootClosed)
+                    {
+                        return fail(TAG_AFTER_ROOT_ERROR, m_currentLocation);
+                    }
+
+                    flushContent();
+                    m_currentTagLocation = m_currentLocation;
+                    m_currentName = Span{m_position + 1, 0};
+                    m_currentFirstAttribute = attributeCount;
+                    m_currentState = State::NAME;
+                }
+                else if (m_rootClosed)
+                {
+                    if (!isWhitespace(c))
+                    {
+                        return fail(CONTENT_AFTER_ROOT_ERROR, m_currentLocation);
+                    }
+                }
+                else if (m_depth == 0)
+                {
+                    return fail(EXPECTED_ROOT_ERROR + quoted(c), m_currentLocation);
+                }
+                return true;
+            }
+
+            constexpr bool name(char c)
+            {
+                if (c == CLOSE_TAG_PREFIX)
+                {
+                    if (m_currentName.length == 0)
+                    {
+                        m_currentCloseName = Span{m_position + 1, 0};
+                        m_currentState = State::CLOSE_NAME;
+                    }
+                    else
+                    {
+                        m_currentState = State::SINGLETON;
+                    }
+                    return true;
+                }
+                if (isValidNameChar(c))
+                {
+                    m_currentName.length++;
+                    return true;
+                }
+                if (c == TAG_END)
+                {
+                    m_currentState = State::WHITESPACE;
+                    return false;
+                }
+                if (isWhitespace(c))
+                {
+                    m_currentState = State::WHITESPACE;
+                    return true;
+                }
+                return fail(EXPECTED_TAG_NAME_ERROR + quoted(c), m_currentLocation);
+            }
+
+            constexpr bool whitespace(char c)
+            {
+                if (isWhitespace(c))
+                {
+                    return true;
+                }
+                if (isValidNameChar(c))
+                {
+                    m_currentAttribName = Span{m_position, 0};
+                    m_currentState = State::ATTRIB_NAME;
+                    return false;
+                }
+                if (c == TAG_END)
+                {
+                    openCurrentElement();
+                    m_contentStart = m_position + 1;
+                    m_currentState = State::START;
+                    return true;
+                }
+                if (c == CLOSE_TAG_PREFIX)
+                {
+                    m_currentState = State::SINGLETON;
+                    return true;
+                }
+                return fail(EXPECTED_ATTRIB_NAME_ERROR + quoted(c), m_currentLocation);
+            }
+
+            constexpr bool attrib_name(char c)
+            {
+                if (isValidNameChar(c))
+                {
+                    m_currentAttribName.length++;
+                    return true;
+                }
+                m_currentState = State::ATTRIB_EQUALS;
+                return false;
+            }
+
+            constexpr bool attrib_equals(char c)
+            {
+                if (isWhitespace(c))
+                {
+                    return true;
+                }
+                if (c == ATTRIB_EQUALS_SIGN)
+                {
+                    m_currentState = State::ATTRIB_EQUALS_SEEN;
+                    return true;
+                }
+                return fail(EXPECTED_EQUALS_ERROR + quoted(c), m_currentLocation);
+            }
+
+            constexpr bool attrib_equals_seen(char c)
+            {
+                if (isWhitespace(c))
+                {
+                    return true;
+                }
+                if (c == ATTRIB_VALUE_WRAP)
+                {
+                    m_currentAttribValue = Span{m_position + 1, 0};
+                    m_currentState = State::ATTRIB_VALUE;
+                    return true;
+                }
+                return fail(EXPECTED_VALUE_ERROR + quoted(c), m_currentLocation);
+            }
+
+            constexpr bool attrib_value(char c)
+            {
+                if (c == ATTRIB_VALUE_WRAP)
+                {
+                    m_currentAttribValue.length = m_position - m_currentAttribValue.offset;
+
+                    // later values replace earlier ones, as with the attribute map
+                    auto first = attributes.begin() + static_cast<std::ptrdiff_t>(m_currentFirstAttribute);
+                    auto last = attributes.begin() + static_cast<std::ptrdiff_t>(attributeCount);
+                    auto existing = std::find_if(first, last,
+                                                 [this](const auto &attribute)
+                                                 { return view(attribute.first) == view(m_currentAttribName); });
+                    if (existing != last)
+                    {
+                        existing->second = m_currentAttribValue;
+                    }
+                    else
+                    {
+                        attributes[attributeCount++] = {m_currentAttribName, m_currentAttribValue};
+                    }
+
+                    m_currentState = State::WHITESPACE;
+                }
+                return true;
+            }
+
+            constexpr bool close_name(char c)
+            {
+                if (isValidNameChar(c))
+                {
+                    m_currentCloseName.length++;
+                    return true;
+                }
+                if (c == TAG_END)
+                {
+                    if (m_depth == 0)
+                    {
+                        return fail(UNEXPECTED_CLOSE_TAG_ERROR + quoted(view(m_currentCloseName)), m_currentLocation);
+                    }
+
+                    std::string_view openName = view(nodes[m_openNodes[m_depth - 1]].tagName);
+                    if (view(m_currentCloseName) != openName)
+                    {
+                        return fail(CLOSE_TAG_MISMATCH_ERROR + quoted(openName) + CLOSE_TAG_MISMATCH_GOT + quoted(view(m_currentCloseName)), m_currentLocation);
+                    }
+
+                    closeElement();
+                    m_contentStart = m_position + 1;
+                    m_currentState = State::START;
+                    return true;
+                }
+                return fail(EXPECTED_TAG_END_ERROR + quoted(c), m_currentLocation);
+            }
+
+            constexpr bool singleton(char c)
+            {
+                if (c == TAG_END)
+                {
+                    openCurrentElement();
+                    closeElement();
+                    m_contentStart = m_position + 1;
+                    m_currentState = State::START;
+                    return true;
+                }
+                return fail(EXPECTED_SINGLETON_END_ERROR + quoted(c), m_currentLocation);
+            }
+
+            // returns true if the character was consumed
+            constexpr bool step(char c)
+            {
+                switch (m_currentState)
+                {
+                case State::START:
+                    return start(c);
+                case State::NAME:
+                    return name(c);
+                case State::WHITESPACE:
+                    return whitespace(c);
+                case State::ATTRIB_NAME:
+                    return attrib_name(c);
+                case State::ATTRIB_EQUALS:
+                    return attrib_equals(c);
+                case State::ATTRIB_EQUALS_SEEN:
+                    return attrib_equals_seen(c);
+                case State::ATTRIB_VALUE:
+                    return attrib_value(c);
+                case State::CLOSE_NAME:
+                    return close_name(c);
+                case State::SINGLETON:
+                    return singleton(c);
+                }
+
+                return fail("parser in malformed state", m_currentLocation);
+            }
+
+        public:
+            constexpr explicit StaticParser(std::string_view text) : source(text)
+            {
+                // index the characters directly, string_view's checked accessors are costly to evaluate
+                const char *chars = source.data();
+                for (; m_position < source.size(); m_position++)
+                {
+                    char c = chars[m_position];
+                    while (!step(c))
+                    {
+                    }
+
+                    if (error.messageLength > 0)
+                    {
+                        return;
+                    }
+
+                    // handle location
+                    if (c == '\n')
+                    {
+                        m_currentLocation.column = 1;
+                        m_currentLocation.line++;
+                    }
+                    else
+                    {
+                        m_currentLocation.column++;
+                    }
+                }
+
+                if (m_currentState != State::START)
+                {
+                    fail(UNEXPECTED_EOF_ERROR, m_currentLocation);
+                    return;
+                }
+
+                if (!m_rootClosed)
+                {
+                    if (m_depth == 0)
+                    {
+                        fail(NO_ROOT_ERROR, m_currentLocation);
+                        return;
+                    }
+
+                    const ParsedNode &unclosed = nodes[m_openNodes[m_depth - 1]];
+                    fail(UNCLOSED_TAG_ERROR + quoted(view(unclosed.tagName)), unclosed.location);
+                    return;
+                }
+
+                for (std::size_t i = 0; i < nodeCount; i++)
+                {
+                    auto begin = attributes.begin() + static_cast<std::ptrdiff_t>(nodes[i].firstAttribute);
+                    std::sort(begin, begin + static_cast<std::ptrdiff_t>(nodes[i].attributeCount),
+                              [this](const auto &first, const auto &second)
+                              { return view(first.first) < view(second.first); });
+                }
+            }
+        };
+
+        template <std::size_t MaxMessageLength>
+        struct StaticSizes
+        {
+            std::size_t nodes, attributes, chars;
+            StaticError<MaxMessageLength> error;
+        };
+
+        // parses the source into tables which must be large enough, returning how much of each was used
+        template <std::size_t Length>
+        constexpr StaticSizes<StaticParser<Length>::MAX_MESSAGE_LENGTH> fillStatic(std::string_view source, StaticNode *nodes, StaticAttribute *attributes, char *chars)
+        {
+            StaticParser<Length> parser{source};
+            if (parser.error.messageLength > 0)
+            {
+                return {0, 0, 0, parser.error};
+            }
+
+            // lay the nodes out breadth first so that the children of each node are contiguous
+            std::array<std::size_t, StaticParser<Length>::MAX_NODES> order{};
+            std::array<std::size_t, StaticParser<Length>::MAX_NODES> position{};
+            for (std::size_t i = 0, ordered = 1; i < ordered; i++)
+            {
+                const auto &parsed = parser.nodes[order[i]];
+                position[order[i]] = i;
+
+                for (std::size_t k = 0, child = parsed.firstChild; k < parsed.childCount; k++, child = parser.nodes[child].nextSibling)
+                {
+                    order[ordered++] = child;
+                }
+            }
+
+            std::size_t nextAttribute = 0;
+            std::size_t nextChar = 0;
+            auto appendChars = [source, chars, &nextChar](const StaticSpan &span)
+            {
+                std::size_t offset = nextChar;
+                std::copy_n(source.data() + span.offset, span.length, chars + nextChar);
+                nextChar += span.length;
+                return offset;
+            };
+
+            for (std::size_t i = 0; i < parser.nodeCount; i++)
+            {
+                const auto &parsed = parser.nodes[order[i]];
+                StaticNode &node = nodes[i];
+
+                node.tagName = appendChars(parsed.tagName);
+                node.tagNameLength = parsed.tagName.length;
+
+                // join the runs of content, leaving out the stripped whitespace
+                node.content = nextChar;
+                node.contentLength = parsed.contentLength;
+
+                std::size_t skip = parsed.contentSkip;
+                std::size_t remaining = parsed.contentLength;
+                for (std::size_t k = 0, run = parsed.firstRun; remaining > 0 && k < parsed.runCount; k++, run = parser.runs[run].next)
+                {
+                    const StaticSpan &span = parser.runs[run].span;
+                    if (skip >= span.length)
+                    {
+                        skip -= span.length;
+                        continue;
+                    }
+
+                    std::size_t length = std::min(span.length - skip, remaining);
+                    appendChars(StaticSpan{span.offset + skip, length});
+                    remaining -= length;
+                    skip = 0;
+                }
+
+                node.firstChild = parsed.childCount == 0 ? 0 : position[parsed.firstChild];
+                node.childCount = parsed.childCount;
+                node.firstAttribute = nextAttribute;
+                node.attributeCount = parsed.attributeCount;
+                node.contentOffset = parsed.contentOffset;
+                node.location = parsed.location;
+
+                for (std::size_t k = 0; k < parsed.attributeCount; k++)
+                {
+                    const auto &attribute = parser.attributes[parsed.firstAttribute + k];
+                    StaticAttribute &staticAttribute = attributes[nextAttribute++];
+                    staticAttribute.name = appendChars(attribute.first);
+                    staticAttribute.nameLength = attribute.first.length;
+                    staticAttribute.value = appendChars(attribute.second);
+                    staticAttribute.valueLength = attribute.second.length;
+                }
+            }
+
+            return {parser.nodeCount, nextAttribute, nextChar, parser.error};
+        }
+
+        template <typename ValueType, ValueType (*Get)(const StaticTable &, std::size_t)>
+        class StaticRange
+        {
+        protected:
+            StaticTable m_table;
+            std::size_t m_first, m_count;
+
+        public:
+            class iterator
+            {
+            private:
+                StaticTable m_table;
+                std::size_t m_index;
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = ValueType;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = ValueType;
+
+                constexpr iterator(const StaticTable &table, std::size_t index) : m_table(table), m_index(index)
+                {
+                }
+
+                constexpr ValueType operator*() const
+                {
+                    return Get(m_table, m_index);
+                }
+
+                constexpr iterator &operator++()
+                {
+                    m_index++;
+                    return *this;
+                }
+
+                constexpr iterator operator++(int)
+                {
+                    iterator previous = *this;
+                    m_index++;
+                    return previous;
+                }
+
+                constexpr bool operator==(const iterator &other) const
+                {
+                    return m_index == other.m_index;
+                }
+
+                constexpr bool operator!=(const iterator &other) const
+                {
+                    return m_index != other.m_index;
+                }
+            };
+
+            constexpr StaticRange(const StaticTable &table, std::size_t first, std::size_t count) : m_table(table), m_first(first), m_count(count)
+            {
+            }
+
+            constexpr iterator begin() const
+            {
+                return iterator{m_table, m_first};
+            }
+
+            constexpr iterator end() const
+            {
+                return iterator{m_table, m_first + m_count};
+            }
+
+            constexpr std::size_t size() const
+            {
+                return m_count;
+            }
+
+            constexpr bool empty() const
+            {
+                return m_count == 0;
+            }
+
+            constexpr ValueType operator[](std::size_t index) const
+            {
+                return Get(m_table, m_first + index);
+            }
+
+            constexpr ValueType at(std::size_t index) const
+            {
+                if (index >= m_count)
+                {
+                    throw std::out_of_range("static range index out of range");
+                }
+
+                return Get(m_table, m_first + index);
+            }
+        };
+
+        constexpr std::pair<std::string_view, std::string_view> getStaticAttribute(const StaticTable &table, std::size_t index)
+        {
+            const StaticAttribute &attribute = table.attributes[index];
+            return {std::string_view(table.chars + attribute.name, attribute.nameLength),
+                    std::string_view(table.chars + attribute.value, attribute.valueLength)};
+        }
+
+        class StaticAttributeRange : public StaticRange<std::pair<std::string_view, std::string_view>, &getStaticAttribute>
+        {
+        private:
+            using Base = StaticRange<std::pair<std::string_view, std::string_view>, &getStaticAttribute>;
+
+        public:
+            using Base::Base;
+            using Base::at;
+
+            /**
+             * @brief Finds an attribute by name using a binary search over the sorted table
+             * 
+             * @param name The name of the attribute
+             * @return iterator The attribute if found, otherwise end()
+             */
+            constexpr iterator find(std::string_view name) const
+            {
+                std::size_t low = 0;
+                std::size_t high = m_count;
+                while (low < high)
+                {
+                    std::size_t middle = low + (high - low) / 2;
+                    if ((*this)[middle].first < name)
+                    {
+                        low = middle + 1;
+                    }
+                    else
+                    {
+                        high = middle;
+                    }
+                }
+
+                if (low < m_count && (*this)[low].first == name)
+                {
+                    return iterator{m_table, m_first + low};
+                }
+
+                return end();
+            }
+
+            constexpr std::size_t count(std::string_view name) const
+            {
+                return find(name) == end() ? 0 : 1;
+            }
+
+            constexpr std::string_view at(std::string_view name) const
+            {
+                iterator attribute = find(name);
+                if (attribute == end())
+                {
+                    throw std::out_of_range("no attribute named: \"" + std::string(name) + "\"");
+                }
+
+                return (*attribute).second;
+            }
+        };
+    }
+
+    /**
+     * @brief Read-only view of a node within a table built at compile time by sml::parseStatic
+     * @remarks Mirrors the accessors of SharedNode, strings are views into the static table
+     */
+    class NodeView
+    {
+    private:
+        detail::StaticTable m_table;
+        std::size_t m_index;
+
+        static constexpr NodeView getChild(const detail::StaticTable &table, std::size_t index)
+        {
+            return NodeView{table, index};
+        }
+
+        constexpr const detail::StaticNode &node() const
+        {
+            return m_table.nodes[m_index];
+        }
+
+    public:
+        using ChildRange = detail::StaticRange<NodeView, &NodeView::getChild>;
+        using AttributeRange = detail::StaticAttributeRange;
+
+        constexpr NodeView(const detail::StaticTable &table, std::size_t index) : m_table(table), m_index(index)
+        {
+        }
+
+        constexpr std::string_view tagName() const
+        {
+            return std::string_view(m_table.chars + node().tagName, node().tagNameLength);
+        }
+
+        constexpr std::string_view content() const
+        {
+            return std::string_view(m_table.chars + node().content, node().contentLength);
+        }
+
+        constexpr ChildRange children() const
+        {
+            return ChildRange{m_table, node().firstChild, node().childCount};
+        }
+
+        /**
+         * @brief Gets the attributes of the node
+         * @remarks Attributes are ordered by name, the same as the attribute map of Node, and can be looked
+         * up by name with find, count and at
+         */
+        constexpr AttributeRange attributes() const
+        {
+            return AttributeRange{m_table, node().firstAttribute, node().attributeCount};
+        }
+
+        constexpr std::size_t contentOffset() const
+        {
+            return node().contentOffset;
+        }
+
+        constexpr Location location() const
+        {
+            return node().location;
+        }
+
+        /**
+         * @brief Gets a descendant of this node
+         * 
+         * @param path The index of the child to follow at each level
+         * @return NodeView The node at the end of the path
+         */
+        constexpr NodeView at(const std::vector<std::size_t> &path) const
+        {
+            NodeView view = *this;
+            for (std::size_t index : path)
+            {
+                view = view.children().at(index);
+            }
+
+            return view;
+        }
+
+        /**
+         * @brief Creates a deep, mutable copy of the node tree
+         * 
+         * @return Node The copied node tree
+         */
+        Node toNode() const
+        {
+            Node copy;
+            copy.tagName = std::string(tagName());
+            copy.content = std::string(content());
+            copy.contentOffset = contentOffset();
+            copy.location = location();
+
+            for (const auto &attribute : attributes())
+            {
+                copy.attributes.emplace(attribute.first, attribute.second);
+            }
+
+            copy.children.reserve(children().size());
+            for (const NodeView &child : children())
+            {
+                copy.children.emplace_back(child.toNode());
+            }
+
+            return copy;
+        }
+    };
+
+    /**
+     * @brief Node table built from a sml literal at compile time
+     */
+    template <std::size_t NodeCount, std::size_t AttributeCount, std::size_t CharCount>
+    struct StaticDocument
+    {
+        std::array<detail::StaticNode, NodeCount> nodes;
+        std::array<detail::StaticAttribute, AttributeCount> attributes;
+        std::array<char, CharCount> chars;
+
+        constexpr NodeView root() const
+        {
+            return NodeView{detail::StaticTable{nodes.data(), attributes.data(), chars.data()}, 0};
+        }
+    };
+
+    /**
+     * @brief String literal which can be passed as a template argument
+     */
+    template <std::size_t Size>
+    struct StaticString
+    {
+        char data[Size] = {};
+
+        constexpr StaticString() = default;
+
+        constexpr StaticString(const char (&str)[Size])
+        {
+            std::copy_n(str, Size, data);
+        }
+
+        constexpr std::string_view view() const
+        {
+            return std::string_view(data, Size - 1);
+        }
+    };
+
+    namespace detail
+    {
+        /**
+         * @brief Instantiated when a literal fails to parse so that the error appears in the build output
+         * 
+         * @tparam Message The message the ParserError would have been given
+         * @tparam Line The line of the error within the literal
+         * @tparam Column The column of the error within the literal
+         */
+        template <StaticString Message, std::size_t Line, std::size_t Column>
+        struct ParseFailed
+        {
+            static_assert(Line == 0, "malformed sml literal, see the ParserError message, line and column of ParseFailed");
+        };
+
+        template <std::size_t Size>
+        constexpr StaticString<Size> toStaticString(const char *str)
+        {
+            StaticString<Size> result;
+            std::copy_n(str, Size - 1, result.data);
+            return result;
+        }
+
+        template <std::size_t NodeCount, std::size_t AttributeCount, std::size_t CharCount>
+        struct BoundedStatic
+        {
+            StaticDocument<NodeCount, AttributeCount, CharCount> document;
+            StaticSizes<StaticParser<CharCount>::MAX_MESSAGE_LENGTH> sizes;
+        };
+
+        template <std::size_t NodeCount, std::size_t AttributeCount, std::size_t CharCount>
+        constexpr BoundedStatic<NodeCount, AttributeCount, CharCount> parseBounded(std::string_view source)
+        {
+            BoundedStatic<NodeCount, AttributeCount, CharCount> bounded{};
+            bounded.sizes = fillStatic<CharCount>(source, bounded.document.nodes.data(), bounded.document.attributes.data(), bounded.document.chars.data());
+            return bounded;
+        }
+
+        template <StaticString Source>
+        constexpr auto buildStatic()
+        {
+            // parse once into tables sized for the worst case, then copy into tables of the exact size
+            constexpr std::size_t length = Source.view().size();
+            using Parser = StaticParser<length>;
+            constexpr auto bounded = parseBounded<Parser::MAX_NODES, Parser::MAX_ATTRIBUTES, length>(Source.view());
+            constexpr auto sizes = bounded.sizes;
+
+            if constexpr (sizes.error.messageLength > 0)
+            {
+                constexpr auto message = toStaticString<sizes.error.messageLength + 1>(sizes.error.message.data());
+                static_cast<void>(ParseFailed<message, sizes.error.location.line, sizes.error.location.column>{});
+
+                return StaticDocument<0, 0, 0>{};
+            }
+            else
+            {
+                StaticDocument<sizes.nodes, sizes.attributes, sizes.chars> document{};
+                std::copy_n(bounded.document.nodes.begin(), sizes.nodes, document.nodes.begin());
+                std::copy_n(bounded.document.attributes.begin(), sizes.attributes, document.attributes.begin());
+                std::copy_n(bounded.document.chars.begin(), sizes.chars, document.chars.begin());
+                return document;
+            }
+        }
+    }
+
+    /**
+     * @brief Node table parsed from a sml literal at compile time
+     * @remarks Malformed input fails the build, naming the ParserError message and its line and column
+     * within the literal. Literals beyond roughly 80 KB exceed GCC's default constant evaluation limit,
+     * which can be raised with -fconstexpr-ops-limit. Only available when SML_STATIC_PARSE is defined.
+     * 
+     * @tparam Source The string literal to be interpreted as sml
+     */
+    template <StaticString Source>
+    inline constexpr auto parseStatic = detail::buildStatic<Source>();
+
+    /**
+     * @brief Writes out a static node to a given output stream
+     * 
+     * @param node The node to be serialised
+     * @param output The output stream to be used
+     */
+    inline void write(const NodeView &node, std::ostream &output)
+    {
+        write(node.toNode(), output);
+    }
+
+    /**
+     * @brief Writes out a static node to a given output string
+     * 
+     * @param node The node to be serialised
+     * @param output The string to be outputed
+     */
+    inline void write(const NodeView &node, std::string &output)
+    {
+        write(node.toNode(), output);
+    }
+
+#endif
 }
\ No newline at end of file
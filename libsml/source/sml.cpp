@@ -1,6 +1,7 @@
 #include "../include/sml.hpp"
 #include <iterator>
 #include <sstream>
+#include <stdexcept>
 
 namespace sml
 {
@@ -11,14 +12,14 @@ namespace sml
 
         raw.erase(raw.begin(), std::find_if(raw.begin(), raw.end(),
                                             [](char ch)
-                                            { return !std::isspace(ch); }));
+                                            { return !detail::isWhitespace(ch); }));
         numRemovedFromLeft = numRemovedFromLeft - raw.size();
 
         std::size_t numRemovedFromRight = raw.size();
 
         raw.erase(std::find_if(raw.rbegin(), raw.rend(),
                                [](char ch)
-                               { return !std::isspace(ch); })
+                               { return !detail::isWhitespace(ch); })
                       .base(),
                   raw.end());
         numRemovedFromRight = numRemovedFromRight - raw.size();
@@ -41,72 +42,123 @@ namespace sml
         }
     }
 
-    static bool isValidNameChar(char c)
+    using detail::isValidNameChar;
+    using detail::isWhitespace;
+
+    using detail::OPEN_TAG;
+    using detail::TAG_END;
+    using detail::CLOSE_TAG_PREFIX;
+    using detail::ATTRIB_EQUALS_SIGN;
+    using detail::ATTRIB_VALUE_WRAP;
+
+    // longest run of content StreamParser holds before handing it on
+    static constexpr std::size_t CONTENT_CHUNK_SIZE = 4096;
+
+    static bool isBlank(const std::string &str)
+    {
+        return std::all_of(str.begin(), str.end(), isWhitespace);
+    }
+
+    static std::string quoted(const std::string &str)
+    {
+        return "\"" + str + "\"";
+    }
+
+    static std::string quoted(char c)
+    {
+        return quoted(std::string(1, c));
+    }
+
+    void EventHandler::consumeElement(Element &element)
+    {
+        startElement(element);
+    }
+
+    StreamParser::StreamParser(EventHandler &handler) : m_handler(&handler)
     {
-        return !std::isspace(c) && c != '<' && c != '>' && c != '=' && c != '/';
     }
 
-    static bool isWhitespace(char c)
+    void StreamParser::flushContent()
     {
-        return std::isspace(c);
+        if (!m_currentContent.empty())
+        {
+            m_handler->content(m_currentContent);
+            m_currentContent.clear();
+        }
+    }
+
+    void StreamParser::openCurrentElement()
+    {
+        // only the name and location are needed to match the close tag
+        m_openTags.push_back(OpenTag{m_currentElement.tagName, m_currentElement.location});
+
+        m_handler->consumeElement(m_currentElement);
+
+        m_currentElement.tagName.clear();
+        m_currentElement.attributes.clear();
     }
 
-    static constexpr char OPEN_TAG = '<';
-    static constexpr char TAG_END = '>';
-    static constexpr char CLOSE_TAG_PREFIX = '/';
-    static constexpr char ATTRIB_EQUALS = '=';
-    static constexpr char ATTRIB_VALUE_WRAP = '"';
+    void StreamParser::closeElement()
+    {
+        m_handler->endElement();
+        m_openTags.pop_back();
+
+        if (m_openTags.empty())
+        {
+            m_rootClosed = true;
+        }
+    }
 
-    Parser::StateChange Parser::start(char c)
+    StreamParser::StateChange StreamParser::start(char c)
     {
         if (c == OPEN_TAG)
         {
             if (m_rootClosed)
             {
-                throw ParserError("opening new tag when the root tag has already been closed",
+                throw ParserError(detail::TAG_AFTER_ROOT_ERROR,
                                   m_currentLocation);
             }
 
             // create new tag
-            // hook the tag into its parents content if it exists
-            std::size_t contentOffset = 0;
-            if (!m_nodeStack.empty())
-            {
-                contentOffset = m_nodeStack.top().content.size();
-            }
-
-            m_nodeStack.emplace();
-            m_nodeStack.top().location = m_currentLocation;
-            m_nodeStack.top().contentOffset = contentOffset;
+            // content before the tag belongs to its parent
+            flushContent();
+            m_currentElement.location = m_currentLocation;
 
             return StateChange{CharOp::CONSUME, State::NAME};
         }
 
         // if there is a tag on the stack add to its content
-        if (m_rootClosed && !std::isspace(c))
+        if (m_rootClosed)
         {
-            throw ParserError("declaring content when the root tag has already been closed",
-                              m_currentLocation);
+            if (!isWhitespace(c))
+            {
+                throw ParserError(detail::CONTENT_AFTER_ROOT_ERROR,
+                                  m_currentLocation);
+            }
         }
-
-        if (!m_nodeStack.empty())
+        else if (!m_openTags.empty())
         {
-            m_nodeStack.top().content.push_back(c);
+            m_currentContent.push_back(c);
+
+            if (m_currentContent.size() >= CONTENT_CHUNK_SIZE)
+            {
+                flushContent();
+            }
         }
         else
         {
-            throw ParserError(std::string("expected root tag, got unexpected character: \"") + c + "\"",
+            throw ParserError(detail::EXPECTED_ROOT_ERROR + quoted(c),
                               m_currentLocation);
         }
 
         return StateChange{CharOp::CONSUME, State::START};
     }
 
-    Parser::StateChange Parser::name(char c)
+    StreamParser::StateChange StreamParser::name(char c)
     {
         if (c == CLOSE_TAG_PREFIX)
         {
-            if (m_nodeStack.top().tagName.empty())
+            if (m_currentElement.tagName.empty())
             {
                 return StateChange{CharOp::CONSUME, State::CLOSE_NAME};
             }
@@ -120,7 +172,7 @@ namespace sml
         if (isValidNameChar(c))
         {
             // build tag name
-            m_nodeStack.top().tagName.push_back(c);
+            m_currentElement.tagName.push_back(c);
 
             return StateChange{CharOp::CONSUME, State::NAME};
         }
@@ -135,11 +187,11 @@ namespace sml
             return StateChange{CharOp::CONSUME, State::WHITESPACE};
         }
 
-        throw ParserError(std::string("expected tag name got unexpected character: \"") + c + "\"",
+        throw ParserError(detail::EXPECTED_TAG_NAME_ERROR + quoted(c),
                           m_currentLocation);
     }
 
-    Parser::StateChange Parser::whitespace(char c)
+    StreamParser::StateChange StreamParser::whitespace(char c)
     {
         if (isWhitespace(c))
         {
@@ -154,6 +206,8 @@ namespace sml
         if (c == TAG_END)
         {
             // terminate the open tag
+            openCurrentElement();
+
             return StateChange{CharOp::CONSUME, State::START};
         }
 
@@ -162,11 +216,11 @@ namespace sml
             return StateChange{CharOp::CONSUME, State::SINGLETON};
         }
 
-        throw ParserError(std::string("expected attrib name got unexpected character: \"") + c + "\"",
+        throw ParserError(detail::EXPECTED_ATTRIB_NAME_ERROR + quoted(c),
                           m_currentLocation);
     }
 
-    Parser::StateChange Parser::attrib_name(char c)
+    StreamParser::StateChange StreamParser::attrib_name(char c)
     {
         if (isValidNameChar(c))
         {
@@ -180,23 +234,23 @@ namespace sml
         return StateChange{CharOp::DEFER, State::ATTRIB_EQUALS};
     }
 
-    Parser::StateChange Parser::attrib_equals(char c)
+    StreamParser::StateChange StreamParser::attrib_equals(char c)
     {
         if (isWhitespace(c))
         {
             return StateChange{CharOp::CONSUME, State::ATTRIB_EQUALS};
         }
 
-        if (c == ATTRIB_EQUALS)
+        if (c == ATTRIB_EQUALS_SIGN)
         {
             return StateChange{CharOp::CONSUME, State::ATTRIB_EQUALS_SEEN};
         }
 
-        throw ParserError(std::string("expected \"=\" got unexpected character: \"") + c + "\"",
+        throw ParserError(detail::EXPECTED_EQUALS_ERROR + quoted(c),
                           m_currentLocation);
     }
 
-    Parser::StateChange Parser::attrib_equals_seen(char c)
+    StreamParser::StateChange StreamParser::attrib_equals_seen(char c)
     {
         if (isWhitespace(c))
         {
@@ -208,16 +262,16 @@ namespace sml
             return StateChange{CharOp::CONSUME, State::ATTRIB_VALUE};
         }
 
-        throw ParserError(std::string("expected '\"' got unexpected character: \"") + c + "\"",
+        throw ParserError(detail::EXPECTED_VALUE_ERROR + quoted(c),
                           m_currentLocation);
     }
 
-    Parser::StateChange Parser::attrib_value(char c)
+    StreamParser::StateChange StreamParser::attrib_value(char c)
     {
         if (c == ATTRIB_VALUE_WRAP)
         {
             // add value and key to attrib map
-            m_nodeStack.top().attributes[m_currentAttribName] = m_currentAttribValue;
+            m_currentElement.attributes[m_currentAttribName] = m_currentAttribValue;
 
             m_currentAttribName.clear();
             m_currentAttribValue.clear();
@@ -231,12 +285,12 @@ namespace sml
         return StateChange{CharOp::CONSUME, State::ATTRIB_VALUE};
     }
 
-    Parser::StateChange Parser::close_name(char c)
+    StreamParser::StateChange StreamParser::close_name(char c)
     {
         if (isValidNameChar(c))
         {
             // build close tag name
-            m_nodeStack.top().tagName.push_back(c);
+            m_currentCloseName.push_back(c);
 
             return StateChange{CharOp::CONSUME, State::CLOSE_NAME};
         }
@@ -244,62 +298,49 @@ namespace sml
         if (c == TAG_END)
         {
             // check that the close tag actually terminates a currently open tag
-            Node closeTag = std::move(m_nodeStack.top());
-            m_nodeStack.pop();
-
-            if (closeTag.tagName != m_nodeStack.top().tagName)
+            if (m_openTags.empty())
             {
-                throw ParserError("expected close tag with tag name: \"" + m_nodeStack.top().tagName + "\" got: \"" + closeTag.tagName + "\"",
+                throw ParserError(detail::UNEXPECTED_CLOSE_TAG_ERROR + quoted(m_currentCloseName),
                                   m_currentLocation);
             }
 
-            if (!m_nodeStack.empty())
+            if (m_currentCloseName != m_openTags.back().tagName)
             {
-                stripNode(m_nodeStack.top());
+                throw ParserError(detail::CLOSE_TAG_MISMATCH_ERROR + quoted(m_openTags.back().tagName) + detail::CLOSE_TAG_MISMATCH_GOT + quoted(m_currentCloseName),
+                                  m_currentLocation);
             }
 
-            // if the close tag matched the node at the top of the stack
-            if (m_nodeStack.size() > 1)
-            {
-                Node tagToClose = std::move(m_nodeStack.top());
-                m_nodeStack.pop();
-
-                m_nodeStack.top().children.emplace_back(std::move(tagToClose));
-            }
-            else
-            {
-                m_rootClosed = true;
-            }
+            m_currentCloseName.clear();
+            closeElement();
 
             return StateChange{CharOp::CONSUME, State::START};
         }
 
-        throw ParserError(std::string("expected '>' got unexpected character: \"") + c + "\"",
+        throw ParserError(detail::EXPECTED_TAG_END_ERROR + quoted(c),
                           m_currentLocation);
     }
 
-    Parser::StateChange Parser::singleton(char c)
+    StreamParser::StateChange StreamParser::singleton(char c)
     {
         if (c == TAG_END)
         {
-            Node singletonTag = std::move(m_nodeStack.top());
-            m_nodeStack.pop();
-            m_nodeStack.top().children.emplace_back(std::move(singletonTag));
+            openCurrentElement();
+            closeElement();
 
             return StateChange{CharOp::CONSUME, State::START};
         }
 
-        throw ParserError(std::string("expected '>' after '/' to close singleton tag, got unexpected character: \"") + c + "\"",
+        throw ParserError(detail::EXPECTED_SINGLETON_END_ERROR + quoted(c),
                           m_currentLocation);
     }
 
-    void Parser::handleChar(char c)
+    void StreamParser::handleChar(char c)
     {
         bool characterConsumed = false;
         while (!characterConsumed)
         {
             // invoke the current state
-            Parser::StateChange handleResult{CharOp::CONSUME, State::START};
+            StreamParser::StateChange handleResult{CharOp::CONSUME, State::START};
             switch (m_currentState)
             {
             case State::START:
@@ -360,51 +401,541 @@ namespace sml
         }
     }
 
-    void Parser::reset()
+    void StreamParser::reset()
     {
         m_currentState = State::START;
 
-        while (!m_nodeStack.empty())
-        {
-            m_nodeStack.pop();
-        }
+        m_openTags.clear();
+
+        m_currentElement.tagName.clear();
+        m_currentElement.attributes.clear();
+        m_currentCloseName.clear();
+        m_currentContent.clear();
 
         m_currentAttribName.clear();
         m_currentAttribValue.clear();
 
-        m_equalsSeen = false;
-        m_terminalTag = false;
         m_rootClosed = false;
 
         m_currentLocation.column = 1;
         m_currentLocation.line = 1;
     }
 
-    Node Parser::finish()
+    void StreamParser::finish()
     {
         if (m_currentState != State::START)
         {
-            throw ParserError("unexpected eof", m_currentLocation);
+            throw ParserError(detail::UNEXPECTED_EOF_ERROR, m_currentLocation);
+        }
+
+        if (!m_rootClosed)
+        {
+            if (m_openTags.empty())
+            {
+                throw ParserError(detail::NO_ROOT_ERROR, m_currentLocation);
+            }
+
+            throw ParserError(detail::UNCLOSED_TAG_ERROR + quoted(m_openTags.back().tagName), m_openTags.back().location);
         }
 
-        if (m_nodeStack.empty())
+        reset();
+    }
+
+    void Parser::TreeBuilder::startElement(const Element &element)
+    {
+        Element copy = element;
+        consumeElement(copy);
+    }
+
+    void Parser::TreeBuilder::consumeElement(Element &element)
+    {
+        // hook the tag into its parents content if it exists
+        std::size_t contentOffset = 0;
+        if (!nodeStack.empty())
         {
-            throw ParserError("no root node found!", m_currentLocation);
+            contentOffset = nodeStack.top().content.size();
         }
 
-        if (m_nodeStack.size() > 1 || !m_rootClosed)
+        nodeStack.emplace();
+        nodeStack.top().tagName = std::move(element.tagName);
+        nodeStack.top().attributes = std::move(element.attributes);
+        nodeStack.top().location = element.location;
+        nodeStack.top().contentOffset = contentOffset;
+    }
+
+    void Parser::TreeBuilder::content(const std::string &content)
+    {
+        nodeStack.top().content += content;
+    }
+
+    void Parser::TreeBuilder::endElement()
+    {
+        stripNode(nodeStack.top());
+
+        // the root is left on the stack for finish to collect
+        if (nodeStack.size() > 1)
         {
-            throw ParserError("unclosed tag: \"" + m_nodeStack.top().tagName + "\"", m_nodeStack.top().location);
+            Node tagToClose = std::move(nodeStack.top());
+            nodeStack.pop();
+
+            nodeStack.top().children.emplace_back(std::move(tagToClose));
         }
+    }
+
+    Parser::Parser() : m_parser(m_builder)
+    {
+    }
+
+    Parser::Parser(const Parser &other) : m_builder(other.m_builder), m_parser(other.m_parser)
+    {
+        // the copied stream parser still reports to the other builder
+        m_parser.m_handler = &m_builder;
+    }
 
-        Node root = std::move(m_nodeStack.top());
-        m_nodeStack.pop();
+    Parser::Parser(Parser &&other) : m_builder(std::move(other.m_builder)), m_parser(std::move(other.m_parser))
+    {
+        m_parser.m_handler = &m_builder;
+    }
+
+    Parser &Parser::operator=(const Parser &other)
+    {
+        m_builder = other.m_builder;
+        m_parser = other.m_parser;
+        m_parser.m_handler = &m_builder;
+
+        return *this;
+    }
+
+    Parser &Parser::operator=(Parser &&other)
+    {
+        m_builder = std::move(other.m_builder);
+        m_parser = std::move(other.m_parser);
+        m_parser.m_handler = &m_builder;
+
+        return *this;
+    }
+
+    void Parser::handleChar(char c)
+    {
+        m_parser.handleChar(c);
+    }
+
+    void Parser::reset()
+    {
+        m_parser.reset();
+
+        while (!m_builder.nodeStack.empty())
+        {
+            m_builder.nodeStack.pop();
+        }
+    }
+
+    Node Parser::finish()
+    {
+        m_parser.finish();
+
+        Node root = std::move(m_builder.nodeStack.top());
+        m_builder.nodeStack.pop();
 
         reset();
 
         return root;
     }
 
+    Filter::Filter(EventHandler &next) : m_next(next)
+    {
+    }
+
+    bool Filter::filterElement(Element &)
+    {
+        return true;
+    }
+
+    void Filter::filterContent(std::string &)
+    {
+    }
+
+    void Filter::finishElement(const Element &)
+    {
+    }
+
+    EventHandler &Filter::next()
+    {
+        return m_next;
+    }
+
+    void Filter::flushContent()
+    {
+        OpenElement &parent = m_openElements.back();
+
+        stripForContent(parent.content);
+
+        if (!parent.content.empty())
+        {
+            filterContent(parent.content);
+        }
+
+        if (!parent.content.empty())
+        {
+            m_next.content(parent.content);
+        }
+
+        parent.content.clear();
+    }
+
+    void Filter::startElement(const Element &element)
+    {
+        if (m_skipDepth > 0)
+        {
+            m_skipDepth++;
+            return;
+        }
+
+        Element copy = element;
+        openElement(copy);
+    }
+
+    void Filter::consumeElement(Element &element)
+    {
+        if (m_skipDepth > 0)
+        {
+            m_skipDepth++;
+            return;
+        }
+
+        openElement(element);
+    }
+
+    void Filter::openElement(Element &element)
+    {
+        if (!filterElement(element))
+        {
+            // the parent keeps buffering, so its content continues across the dropped subtree
+            m_skipDepth = 1;
+            return;
+        }
+
+        if (!m_openElements.empty())
+        {
+            flushContent();
+        }
+
+        // keep the element for finishElement and forward the kept copy
+        m_openElements.push_back(OpenElement{std::move(element), std::string()});
+        m_next.startElement(m_openElements.back().element);
+    }
+
+    void Filter::content(const std::string &content)
+    {
+        if (m_skipDepth > 0 || m_openElements.empty())
+        {
+            return;
+        }
+
+        m_openElements.back().content += content;
+    }
+
+    void Filter::endElement()
+    {
+        if (m_skipDepth > 0)
+        {
+            m_skipDepth--;
+            return;
+        }
+
+        flushContent();
+        finishElement(m_openElements.back().element);
+
+        m_openElements.pop_back();
+        m_next.endElement();
+    }
+
+    Writer::Writer(std::ostream &output) : m_output(output)
+    {
+    }
+
+    void Writer::startElement(const Element &element)
+    {
+        if (!m_openTags.empty())
+        {
+            OpenTag &parent = m_openTags.back();
+
+            if (parent.state != TagState::CHILDREN)
+            {
+                if (parent.state == TagState::OPEN)
+                {
+                    m_output << ">\n";
+                }
+
+                // trailing whitespace is stripped from the content
+                parent.pendingWhitespace.clear();
+                parent.state = TagState::CHILDREN;
+            }
+        }
+
+        // open print tag
+        std::fill_n(std::ostream_iterator<char>(m_output), m_openTags.size(), '\t');
+
+        // print attributes
+        m_output << "<" << element.tagName;
+
+        for (const auto &keyValue : element.attributes)
+        {
+            m_output << " " << keyValue.first << "=\"" << keyValue.second << "\"";
+        }
+
+        m_openTags.push_back(OpenTag{element.tagName, std::string(), TagState::OPEN});
+    }
+
+    void Writer::content(const std::string &content)
+    {
+        if (m_openTags.empty())
+        {
+            return;
+        }
+
+        OpenTag &tag = m_openTags.back();
+        if (tag.state == TagState::CHILDREN)
+        {
+            // sml::write puts content before children, which have already been written
+            if (!isBlank(content))
+            {
+                throw StreamError("content following a child of tag: \"" + tag.tagName + "\" cannot be written");
+            }
+
+            return;
+        }
+
+        auto last = std::find_if(content.rbegin(), content.rend(),
+                                 [](char ch)
+                                 { return !isWhitespace(ch); })
+                        .base();
+
+        if (last == content.begin())
+        {
+            // leading whitespace is stripped, anything else is held back until it is known not to be trailing
+            if (tag.state == TagState::CONTENT)
+            {
+                tag.pendingWhitespace += content;
+            }
+
+            return;
+        }
+
+        auto first = content.begin();
+        if (tag.state == TagState::OPEN)
+        {
+            first = std::find_if(content.begin(), last,
+                                 [](char ch)
+                                 { return !isWhitespace(ch); });
+
+            m_output << ">";
+            tag.state = TagState::CONTENT;
+        }
+        else
+        {
+            m_output << tag.pendingWhitespace;
+        }
+
+        m_output.write(&*first, std::distance(first, last));
+        tag.pendingWhitespace.assign(last, content.end());
+    }
+
+    void Writer::endElement()
+    {
+        OpenTag &tag = m_openTags.back();
+
+        switch (tag.state)
+        {
+        case TagState::OPEN:
+            // create short tag if it has no children
+            m_output << "/>\n";
+            break;
+        case TagState::CHILDREN:
+            std::fill_n(std::ostream_iterator<char>(m_output), m_openTags.size() - 1, '\t');
+            m_output << "</" << tag.tagName << ">\n";
+            break;
+        case TagState::CONTENT:
+            m_output << "</" << tag.tagName << ">\n";
+            break;
+        }
+
+        m_openTags.pop_back();
+    }
+
+    SharedNode::SharedNode(std::shared_ptr<const Data> data) : m_data(std::move(data))
+    {
+    }
+
+    template <typename EditType>
+    SharedNode SharedNode::edit(EditType editData) const
+    {
+        // copy this node only, the children are shared with the original
+        auto data = std::make_shared<Data>(*m_data);
+        editData(*data);
+        return SharedNode{std::shared_ptr<const Data>(std::move(data))};
+    }
+
+    SharedNode::SharedNode() : m_data(std::make_shared<const Data>(Data{{}, {}, {}, {}, 0, Location{1, 1}}))
+    {
+    }
+
+    SharedNode::SharedNode(const Node &node)
+    {
+        auto data = std::make_shared<Data>();
+        data->tagName = node.tagName;
+        data->content = node.content;
+        data->attributes = node.attributes;
+        data->contentOffset = node.contentOffset;
+        data->location = node.location;
+
+        data->children.reserve(node.children.size());
+        for (const Node &child : node.children)
+        {
+            data->children.emplace_back(child);
+        }
+
+        m_data = std::move(data);
+    }
+
+    const std::string &SharedNode::tagName() const
+    {
+        return m_data->tagName;
+    }
+
+    const std::string &SharedNode::content() const
+    {
+        return m_data->content;
+    }
+
+    const std::vector<SharedNode> &SharedNode::children() const
+    {
+        return m_data->children;
+    }
+
+    const std::map<std::string, std::string> &SharedNode::attributes() const
+    {
+        return m_data->attributes;
+    }
+
+    std::size_t SharedNode::contentOffset() const
+    {
+        return m_data->contentOffset;
+    }
+
+    Location SharedNode::location() const
+    {
+        return m_data->location;
+    }
+
+    const SharedNode &SharedNode::at(const std::vector<std::size_t> &path) const
+    {
+        const SharedNode *node = this;
+        for (std::size_t index : path)
+        {
+            node = &node->children().at(index);
+        }
+
+        return *node;
+    }
+
+    SharedNode SharedNode::withTagName(std::string tagName) const
+    {
+        return edit([&tagName](Data &data)
+                    { data.tagName = std::move(tagName); });
+    }
+
+    SharedNode SharedNode::withContent(std::string content) const
+    {
+        return edit([&content](Data &data)
+                    { data.content = std::move(content); });
+    }
+
+    SharedNode SharedNode::withAttribute(const std::string &name, std::string value) const
+    {
+        return edit([&name, &value](Data &data)
+                    { data.attributes[name] = std::move(value); });
+    }
+
+    SharedNode SharedNode::withoutAttribute(const std::string &name) const
+    {
+        return edit([&name](Data &data)
+                    { data.attributes.erase(name); });
+    }
+
+    SharedNode SharedNode::withChild(std::size_t index, SharedNode child) const
+    {
+        if (index >= children().size())
+        {
+            throw std::out_of_range("child index out of range");
+        }
+
+        return edit([index, &child](Data &data)
+                    { data.children[index] = std::move(child); });
+    }
+
+    SharedNode SharedNode::withChildInserted(std::size_t index, SharedNode child) const
+    {
+        if (index > children().size())
+        {
+            throw std::out_of_range("child index out of range");
+        }
+
+        return edit([index, &child](Data &data)
+                    { data.children.insert(data.children.begin() + static_cast<std::ptrdiff_t>(index), std::move(child)); });
+    }
+
+    SharedNode SharedNode::withoutChild(std::size_t index) const
+    {
+        if (index >= children().size())
+        {
+            throw std::out_of_range("child index out of range");
+        }
+
+        return edit([index](Data &data)
+                    { data.children.erase(data.children.begin() + static_cast<std::ptrdiff_t>(index)); });
+    }
+
+    SharedNode SharedNode::withDescendant(const std::vector<std::size_t> &path, SharedNode replacement) const
+    {
+        // collect the nodes along the path, these are the only ones that need copying
+        std::vector<const SharedNode *> ancestors;
+        ancestors.reserve(path.size());
+
+        const SharedNode *node = this;
+        for (std::size_t index : path)
+        {
+            ancestors.push_back(node);
+            node = &node->children().at(index);
+        }
+
+        // rebuild from the bottom up
+        for (std::size_t i = path.size(); i > 0; i--)
+        {
+            replacement = ancestors[i - 1]->withChild(path[i - 1], std::move(replacement));
+        }
+
+        return replacement;
+    }
+
+    Node SharedNode::toNode() const
+    {
+        Node node;
+        node.tagName = tagName();
+        node.content = content();
+        node.attributes = attributes();
+        node.contentOffset = contentOffset();
+        node.location = location();
+
+        node.children.reserve(children().size());
+        for (const SharedNode &child : children())
+        {
+            node.children.emplace_back(child.toNode());
+        }
+
+        return node;
+    }
+
     std::istream &operator>>(std::istream &str, sml::Node &node)
     {
         sml::Parser p;
@@ -438,14 +969,66 @@ namespace sml
         return node;
     }
 
-    void write(const Node &node, std::ostream &output)
+    void parse(const std::string &str, EventHandler &handler)
+    {
+        parse(str.begin(), str.end(), handler);
+    }
+
+    void parse(std::istream &str, EventHandler &handler)
+    {
+        parse(std::istreambuf_iterator<char>(str), std::istreambuf_iterator<char>(), handler);
+    }
+
+    // field access shared by both node representations so they can be written the same way
+    static const std::string &tagNameOf(const Node &node)
+    {
+        return node.tagName;
+    }
+
+    static const std::string &contentOf(const Node &node)
+    {
+        return node.content;
+    }
+
+    static const std::vector<Node> &childrenOf(const Node &node)
+    {
+        return node.children;
+    }
+
+    static const std::map<std::string, std::string> &attributesOf(const Node &node)
+    {
+        return node.attributes;
+    }
+
+    static const std::string &tagNameOf(const SharedNode &node)
+    {
+        return node.tagName();
+    }
+
+    static const std::string &contentOf(const SharedNode &node)
+    {
+        return node.content();
+    }
+
+    static const std::vector<SharedNode> &childrenOf(const SharedNode &node)
+    {
+        return node.children();
+    }
+
+    static const std::map<std::string, std::string> &attributesOf(const SharedNode &node)
+    {
+        return node.attributes();
+    }
+
+    template <typename NodeType>
+    static void writeTree(const NodeType &node, std::ostream &output)
     {
         struct Tag
         {
-            const Node &node;
+            const NodeType &node;
             bool expanded;
 
-            Tag(const Node &n, bool exp = false) : node(n), expanded(exp)
+            Tag(const NodeType &n, bool exp = false) : node(n), expanded(exp)
             {
             }
         };
@@ -465,15 +1048,15 @@ namespace sml
                 std::fill_n(std::ostream_iterator<char>(output), depth, '\t');
 
                 // print attributes
-                output << "<" << tagToExpand.node.tagName;
+                output << "<" << tagNameOf(tagToExpand.node);
 
-                for (const auto &keyValue : tagToExpand.node.attributes)
+                for (const auto &keyValue : attributesOf(tagToExpand.node))
                 {
                     output << " " << keyValue.first << "=\"" << keyValue.second << "\"";
                 }
 
                 // create short tag if it has no children
-                if (tagToExpand.node.children.empty() && tagToExpand.node.content.empty())
+                if (childrenOf(tagToExpand.node).empty() && contentOf(tagToExpand.node).empty())
                 {
                     expandStack.pop();
 
@@ -483,8 +1066,8 @@ namespace sml
                 {
                     // expand children
                     std::for_each(
-                        tagToExpand.node.children.rbegin(),
-                        tagToExpand.node.children.rend(),
+                        childrenOf(tagToExpand.node).rbegin(),
+                        childrenOf(tagToExpand.node).rend(),
                         [&expandStack](const auto &child)
                         { expandStack.push(Tag{child}); });
 
@@ -493,13 +1076,13 @@ namespace sml
 
                     output << ">";
 
-                    if (tagToExpand.node.content.empty())
+                    if (contentOf(tagToExpand.node).empty())
                     {
                         output << "\n";
                     }
 
                     // print content
-                    output << tagToExpand.node.content;
+                    output << contentOf(tagToExpand.node);
                 }
             }
             else
@@ -509,22 +1092,39 @@ namespace sml
                 {
                     depth--;
 
-                    if (!expandStack.top().node.children.empty())
+                    if (!childrenOf(expandStack.top().node).empty())
                     {
                         std::fill_n(std::ostream_iterator<char>(output), depth, '\t');
                     }
 
-                    output << "</" << expandStack.top().node.tagName << ">" << std::endl;
+                    output << "</" << tagNameOf(expandStack.top().node) << ">" << std::endl;
                     expandStack.pop();
                 }
             }
         }
     }
 
+    void write(const Node &node, std::ostream &output)
+    {
+        writeTree(node, output);
+    }
+
     void write(const Node &node, std::string &output)
     {
         std::ostringstream ss;
         write(node, ss);
         output = ss.str();
     }
+
+    void write(const SharedNode &node, std::ostream &output)
+    {
+        writeTree(node, output);
+    }
+
+    void write(const SharedNode &node, std::string &output)
+    {
+        std::ostringstream ss;
+        write(node, ss);
+        output = ss.str();
+    }
 }
\ No newline at end of file
@@ -3,6 +3,13 @@
 #include <sstream>
 #include <sml.hpp>
 
+#ifdef SML_STATIC_PARSE
+// parsed at compile time, costs nothing at startup
+constexpr const auto &defaultLayout = sml::parseStatic<R"(<frame xAnchor="center" yAnchor="center">
+    <button height="0.5rel" id="default-button"> Default </button>
+</frame>)">;
+#endif
+
 int main()
 {
     std::ifstream ss{ "../examples/simple.sml" };
@@ -11,6 +18,10 @@ int main()
     ss >> node;
 
     std::cout << node;
+
+#ifdef SML_STATIC_PARSE
+    std::cout << defaultLayout.root().toNode();
+#endif
   
     return 0;
-}
\ No newline at end of file
+}